@@ -0,0 +1,54 @@
+#include <3ds.h>
+#include <citro2d.h>
+
+#include <string.h>
+#include <strings.h>
+
+#include "wheel.h"
+#include "cache.h"
+
+// most recently used first
+static Wheel *cache[WHEEL_CACHE_SIZE];
+static int numCached = 0;
+
+Wheel *getWheel(const char *name) {
+    int i;
+    for (i = 0; i < numCached; i++) {
+        // names are file names, and the SD card's file system ignores case
+        if (strcasecmp(cache[i]->name, name) == 0) break;
+    }
+
+    Wheel *w;
+    if (i < numCached) {
+        w = cache[i];
+    } else {
+        w = newWheel(name);
+        if (!w) return NULL;
+
+        if (numCached == WHEEL_CACHE_SIZE) {
+            // evict the least recently used wheel, writing back any changes first
+            i = numCached - 1;
+            if (cache[i]->dirty) {
+                saveWheelOptions(cache[i]);
+            }
+            freeWheel(cache[i]);
+        } else {
+            i = numCached++;
+        }
+    }
+
+    memmove(&cache[1], &cache[0], i * sizeof(Wheel *));
+    cache[0] = w;
+
+    return w;
+}
+
+void freeWheelCache(void) {
+    for (int i = 0; i < numCached; i++) {
+        if (cache[i]->dirty) {
+            saveWheelOptions(cache[i]);
+        }
+        freeWheel(cache[i]);
+    }
+    numCached = 0;
+}
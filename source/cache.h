@@ -0,0 +1,5 @@
+#define WHEEL_CACHE_SIZE 4
+
+// returns NULL if the wheel isn't cached and there's no memory to load it
+Wheel *getWheel(const char *name);
+void freeWheelCache(void);
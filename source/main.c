@@ -1,17 +1,22 @@
 #include <3ds.h>
 #include <citro2d.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include "wheel.h"
+#include "cache.h"
 #include "main.h"
 
+#define MAX_WHEEL_DEPTH 16
+
 u32 white, gray, black, darkGray, scrollGray;
 u32 optionColors[NUM_COLORS];
 bool darkText[NUM_COLORS] = { false, false, false, true /* yellow */,  false, true /* cyan */ };
 
-C2D_TextBuf staticTextBuf, dynamicTextBuf;
-C2D_Text selectedText, continueText, removeText, addText, aText, duplicateText, hideText, shuffleText;
+C2D_TextBuf staticTextBuf;
+C3D_Tex *glyphSheets;
+C2D_Text selectedText, continueText, openText, backText, linkText, removeText, addText, aText, duplicateText, hideText, shuffleText;
 
 void initGfx(C3D_RenderTarget **top, C3D_RenderTarget **bottom) {
     gfxInitDefault();
@@ -38,12 +43,35 @@ void initColors(void) {
     optionColors[5] = C2D_Color32(0x00, 0xFF, 0xFF, 0xFF);
 }
 
+void initGlyphSheets(void) {
+    // same setup citro2d does internally for the system font, so that single
+    // glyphs can be drawn as images (used for the labels on the wheel)
+    fontEnsureMapped();
+    TGLP_s *glyphInfo = fontGetGlyphInfo(NULL);
+
+    glyphSheets = malloc(sizeof(C3D_Tex) * glyphInfo->nSheets);
+    for (int i = 0; i < glyphInfo->nSheets; i++) {
+        C3D_Tex *tex = &glyphSheets[i];
+        tex->data = fontGetGlyphSheetTex(NULL, i);
+        tex->fmt = glyphInfo->sheetFmt;
+        tex->size = glyphInfo->sheetSize;
+        tex->width = glyphInfo->sheetWidth;
+        tex->height = glyphInfo->sheetHeight;
+        tex->param = GPU_TEXTURE_MAG_FILTER(GPU_LINEAR) | GPU_TEXTURE_MIN_FILTER(GPU_LINEAR)
+                     | GPU_TEXTURE_WRAP_S(GPU_CLAMP_TO_BORDER) | GPU_TEXTURE_WRAP_T(GPU_CLAMP_TO_BORDER);
+        tex->border = 0xFFFFFFFF;
+        tex->lodParam = 0;
+    }
+}
+
 void initText(void) {
     staticTextBuf = C2D_TextBufNew(1024);
-    dynamicTextBuf = C2D_TextBufNew(4096);
 
     C2D_TextParse(&selectedText, staticTextBuf, "selected");
     C2D_TextParse(&continueText, staticTextBuf, "\uE000 Continue");
+    C2D_TextParse(&openText, staticTextBuf, "\uE000 Open wheel");
+    C2D_TextParse(&backText, staticTextBuf, "\uE001 Back");
+    C2D_TextParse(&linkText, staticTextBuf, "\u00BB");
     C2D_TextParse(&removeText, staticTextBuf, "\uE002 Remove and continue");
     C2D_TextParse(&addText, staticTextBuf, "Press \uE003 to add a new option");
     C2D_TextParse(&aText, staticTextBuf, "\uE000");
@@ -53,24 +81,29 @@ void initText(void) {
 
     C2D_TextOptimize(&selectedText);
     C2D_TextOptimize(&continueText);
+    C2D_TextOptimize(&openText);
+    C2D_TextOptimize(&backText);
+    C2D_TextOptimize(&linkText);
     C2D_TextOptimize(&removeText);
     C2D_TextOptimize(&addText);
     C2D_TextOptimize(&aText);
     C2D_TextOptimize(&duplicateText);
     C2D_TextOptimize(&hideText);
     C2D_TextOptimize(&shuffleText);
+
+    initGlyphSheets();
 }
 
 void finish(void) {
     C2D_TextBufDelete(staticTextBuf);
-    C2D_TextBufDelete(dynamicTextBuf);
+    free(glyphSheets);
 
     C2D_Fini();
     C3D_Fini();
     gfxExit();
 }
 
-void drawPopup(const C2D_Text *text, u32 color, bool useDarkText) {
+void drawPopup(const C2D_Text *text, u32 color, bool useDarkText, bool linked) {
     float textWidth, textHeight, textScale = 1.0f;
     C2D_TextGetDimensions(text, textScale, textScale, &textWidth, &textHeight);
 
@@ -88,7 +121,7 @@ void drawPopup(const C2D_Text *text, u32 color, bool useDarkText) {
     C2D_DrawText(text, C2D_WithColor, 210.0f - colorWidth / 2.0f, 105.0f - textScale * textHeight / 2, 0.0f, textScale, textScale, useDarkText ? black : white);
 
     C2D_DrawText(&selectedText, 0, 173.0f, 130.0f, 0.0f, 0.5f, 0.5f);
-    C2D_DrawText(&continueText, 0, 80.0f, 170.0f, 0.0f, 0.5f, 0.5f);
+    C2D_DrawText(linked ? &openText : &continueText, 0, 80.0f, 170.0f, 0.0f, 0.5f, 0.5f);
     C2D_DrawText(&removeText, 0, 185.0f, 170.0f, 0.0f, 0.5f, 0.5f);
 }
 
@@ -113,7 +146,7 @@ void drawBar(bool duplicated, bool hidden, bool shuffled) {
     C2D_DrawText(&shuffleText, C2D_WithColor | C2D_AlignCenter, BTN_HPAD + 2 * BTN_WIDTH + BTN_WIDTH / 2, BOTTOM_HEIGHT - BAR_HEIGHT + BTN_VPAD + TEXT_VPAD, 0.0f, 0.5f, 0.5f, shuffled ? white : black);
 }
 
-void render(C3D_RenderTarget *top, C3D_RenderTarget *bottom, const Wheel *wheel, float scroll, float maxScroll, bool hidden, bool shuffleHeld) {
+void render(C3D_RenderTarget *top, C3D_RenderTarget *bottom, const Wheel *wheel, float scroll, float maxScroll, bool hidden, bool shuffleHeld, int depth) {
     C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
 
     C2D_TargetClear(top, white);
@@ -125,7 +158,8 @@ void render(C3D_RenderTarget *top, C3D_RenderTarget *bottom, const Wheel *wheel,
         if (wheel->finishedSpin) {
             drawPopup(&wheel->optionsText[wheel->selectedOption],
                       optionColors[getColorIndex(wheel->selectedOption, wheel->numOptions, 1, false)],
-                      darkText[wheel->selectedOption]);
+                      darkText[wheel->selectedOption],
+                      wheel->links[wheel->selectedOption][0] != '\0' && depth < MAX_WHEEL_DEPTH - 1);
         } else {
             if (wheel->numOptions > 0) {
                 C2D_DrawCircleSolid(wheel->centerX, wheel->centerY, 0.0f, 15.0f, black);
@@ -133,6 +167,9 @@ void render(C3D_RenderTarget *top, C3D_RenderTarget *bottom, const Wheel *wheel,
             if (!wheel->spinning) {
                 C2D_DrawText(&aText, C2D_WithColor, 188.5f, 105.0f, 0.0f, 1.0f, 1.0f, white);
                 C2D_DrawText(&addText, 0, 115.0f, 220.0f, 0.0f, 0.5f, 0.5f);
+                if (depth > 0) {
+                    C2D_DrawText(&backText, 0, 5.0f, 5.0f, 0.0f, 0.5f, 0.5f);
+                }
             }
         }
     }
@@ -176,7 +213,7 @@ void handleTouch(Wheel *wheel, float *scroll, bool *barHeld, bool *hidden, int *
             if (touchPos.py >= BOTTOM_HEIGHT - BAR_HEIGHT + BTN_VPAD && touchPos.py < BOTTOM_HEIGHT - BTN_VPAD) {
 
                 if (touchPos.px >= BTN_HPAD && touchPos.px < BTN_HPAD + BTN_WIDTH - 2) {
-                    wheel->duplicated = !wheel->duplicated;
+                    setWheelDuplicated(wheel, !wheel->duplicated);
                 } else if (touchPos.px >= BTN_HPAD + BTN_WIDTH && touchPos.px < BTN_HPAD + 2 * BTN_WIDTH - 2) {
                     *hidden = !*hidden;
                 } else if (touchPos.px >= BTN_HPAD + 2 * BTN_WIDTH && touchPos.px < BTN_HPAD + 3 * BTN_WIDTH - 2) {
@@ -199,10 +236,11 @@ void handleTouch(Wheel *wheel, float *scroll, bool *barHeld, bool *hidden, int *
             if (x >= PAD + BORDER && x <= BOTTOM_WIDTH - PAD - BORDER - HEIGHT) {
                 SwkbdState swkbd;
                 swkbdInit(&swkbd, SWKBD_TYPE_NORMAL, 2, MAX_OPTION_LEN - 1);
-                swkbdSetInitialText(&swkbd, wheel->options[selectedOption]);
-
                 static char buf[MAX_OPTION_LEN] = "";
 
+                getWheelOptionLine(wheel, selectedOption, buf, MAX_OPTION_LEN);
+                swkbdSetInitialText(&swkbd, buf);
+
                 SwkbdButton button = swkbdInputText(&swkbd, buf, MAX_OPTION_LEN);
                 if (button == SWKBD_BUTTON_CONFIRM) {
                     modifyWheelOption(wheel, selectedOption, buf);
@@ -229,9 +267,11 @@ int main() {
     initText();
     atexit(finish);
 
-    Wheel wheel;
-    initWheel(&wheel);
-    fetchWheelOptions(&wheel);
+    // names of the wheels from the root down to the current one
+    static char wheelStack[MAX_WHEEL_DEPTH][MAX_LINK_LEN] = { "" };
+    int depth = 0;
+    Wheel *wheel = getWheel(wheelStack[depth]);
+    if (!wheel) return 1;
 
     float scroll = 0.0f, maxScroll = 0.0f;
     int shuffleHeld = 0;
@@ -254,40 +294,57 @@ int main() {
             }
         }
 
-        if (wheel.spinning) {
-            updateWheel(&wheel);
-        } else if (wheel.finishedSpin) {
+        if (wheel->spinning) {
+            updateWheel(wheel);
+        } else if (wheel->finishedSpin) {
             if (kDown & KEY_A) {
-                wheel.finishedSpin = false;
-            }
-            if (kDown & KEY_X) {
-                wheel.finishedSpin = false;
-                removeWheelOption(&wheel, wheel.selectedOption);
+                wheel->finishedSpin = false;
+
+                const char *link = wheel->links[wheel->selectedOption];
+                Wheel *child = link[0] && depth < MAX_WHEEL_DEPTH - 1 ? getWheel(link) : NULL;
+                if (child) {
+                    depth++;
+                    strncpy(wheelStack[depth], link, MAX_LINK_LEN);
+                    wheel = child;
+                    scroll = 0.0f;
+                }
+            } else if (kDown & KEY_X) {
+                wheel->finishedSpin = false;
+                removeWheelOption(wheel, wheel->selectedOption);
             }
         } else {
-            if (kDown & KEY_Y && wheel.numOptions < MAX_OPTIONS - 1) {
-                SwkbdButton button = swkbdInputText(&swkbd, wheel.options[wheel.numOptions], MAX_OPTION_LEN);
+            if (kDown & KEY_B && depth > 0) {
+                Wheel *parent = getWheel(wheelStack[depth - 1]);
+                if (parent) {
+                    depth--;
+                    wheel = parent;
+                    scroll = 0.0f;
+                }
+            }
+
+            if (kDown & KEY_Y && wheel->numOptions < MAX_OPTIONS - 1) {
+                SwkbdButton button = swkbdInputText(&swkbd, wheel->options[wheel->numOptions], MAX_OPTION_LEN);
                 if (button == SWKBD_BUTTON_CONFIRM) {
-                    addWheelOption(&wheel);
+                    addWheelOption(wheel);
                 }
             }
 
-            if (kDown & KEY_A && wheel.numOptions > 0) {
+            if (kDown & KEY_A && wheel->numOptions > 0) {
                 float angle = drand48() * 360.0f;
-                spinWheelTo(&wheel, angle);
+                spinWheelTo(wheel, angle);
             }
 
-            handleTouch(&wheel, &scroll, &barHeld, &hidden, &shuffleHeld);
+            handleTouch(wheel, &scroll, &barHeld, &hidden, &shuffleHeld);
 
-            maxScroll = wheel.numOptions * (HEIGHT + PAD) - BOTTOM_HEIGHT + PAD + BAR_HEIGHT;
+            maxScroll = wheel->numOptions * (HEIGHT + PAD) - BOTTOM_HEIGHT + PAD + BAR_HEIGHT;
             scroll = MIN(scroll, maxScroll);
             scroll = MAX(scroll, 0.0f);
         }
 
-        render(top, bottom, &wheel, scroll, maxScroll, hidden, shuffleHeld);
+        render(top, bottom, wheel, scroll, maxScroll, hidden, shuffleHeld, depth);
     }
 
-    saveWheelOptions(&wheel);
+    freeWheelCache();
 
     return 0;
 }
\ No newline at end of file
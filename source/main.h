@@ -6,7 +6,9 @@
 
 #define NUM_COLORS 6
 extern u32 optionColors[NUM_COLORS];
-extern C2D_TextBuf dynamicTextBuf;
+extern bool darkText[NUM_COLORS];
+extern C3D_Tex *glyphSheets;
+extern C2D_Text linkText;
 extern u32 white, gray, black;
 
 #define BOTTOM_WIDTH 320.0f
@@ -1,6 +1,7 @@
 #include <3ds.h>
 #include <citro2d.h>
 
+#include <ctype.h>
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
@@ -10,14 +11,177 @@
 #include "wheel.h"
 #include "main.h"
 
+static float getWheelRadius(const Wheel *w) {
+    if (w->numOptions <= 3) {
+        // looks weird going from 4 to 3 colors without this
+        return w->radius * 0.9f;
+    }
+    return w->radius;
+}
+
+static void layoutWheelLabel(WheelLabel *label, const char *str, float scale, float innerRadius, float outerRadius) {
+    TGLP_s *glyphInfo = fontGetGlyphInfo(NULL);
+    float maxWidth = (outerRadius - innerRadius) / scale;
+
+    fontGlyphPos_s dot;
+    fontCalcGlyphPos(&dot, NULL, fontGlyphIndexFromCodePoint(NULL, '.'), GLYPH_POS_CALC_VTXCOORD, 1.0f, 1.0f);
+
+    fontGlyphPos_s pos[MAX_LABEL_GLYPHS];
+    float penBefore[MAX_LABEL_GLYPHS];
+    float pen = 0.0f;
+    int n = 0;
+    bool truncated = false;
+
+    const u8 *p = (const u8 *) str;
+    while (*p) {
+        u32 code;
+        ssize_t units = decode_utf8(&code, p);
+        if (units <= 0) break;
+        p += units;
+
+        if (n >= MAX_LABEL_GLYPHS) {
+            truncated = true;
+            break;
+        }
+
+        fontCalcGlyphPos(&pos[n], NULL, fontGlyphIndexFromCodePoint(NULL, code), GLYPH_POS_CALC_VTXCOORD, 1.0f, 1.0f);
+        if (pen + pos[n].xAdvance > maxWidth) {
+            truncated = true;
+            break;
+        }
+
+        penBefore[n] = pen;
+        pen += pos[n].xAdvance;
+        n++;
+    }
+
+    if (truncated) {
+        // drop glyphs until there's room for "..."
+        while (n > 0 && (n + 3 > MAX_LABEL_GLYPHS || pen + 3 * dot.xAdvance > maxWidth)) {
+            n--;
+            pen = penBefore[n];
+        }
+
+        // not even "..." fits
+        if (pen + 3 * dot.xAdvance > maxWidth) {
+            label->numGlyphs = 0;
+            return;
+        }
+
+        for (int i = 0; i < 3; i++) {
+            pos[n] = dot;
+            penBefore[n] = pen;
+            pen += dot.xAdvance;
+            n++;
+        }
+    }
+
+    // right-aligned against the rim, where the sector is widest
+    float start = outerRadius - pen * scale;
+
+    for (int i = 0; i < n; i++) {
+        WheelGlyph *g = &label->glyphs[i];
+        g->sheet = pos[i].sheetIndex;
+        g->x = start + (penBefore[i] + pos[i].xOffset) * scale;
+        g->y = -glyphInfo->cellHeight * scale / 2.0f;
+
+        g->subtex.width = pos[i].width;
+        g->subtex.height = glyphInfo->cellHeight;
+        g->subtex.left = pos[i].texcoord.left;
+        g->subtex.top = pos[i].texcoord.top;
+        g->subtex.right = pos[i].texcoord.right;
+        g->subtex.bottom = pos[i].texcoord.bottom;
+    }
+    label->numGlyphs = n;
+}
+
+static void updateWheelLabels(Wheel *w) {
+    w->labelScale = 0.0f;
+    if (w->numOptions == 0) return;
+
+    int numSlots = w->numOptions * (w->duplicated ? 3 : 1);
+    float radius = getWheelRadius(w);
+
+    // fit the text height to the width of a sector three quarters of the way out
+    float slotWidth = 2.0f * M_PI * radius * 0.75f / numSlots;
+    float scale = MIN(slotWidth * LABEL_FILL / fontGetGlyphInfo(NULL)->cellHeight, LABEL_MAX_SCALE);
+
+    // too cramped to be readable
+    if (scale < LABEL_MIN_SCALE) return;
+
+    // closer in than this, neighbouring labels would overlap
+    float labelHeight = fontGetGlyphInfo(NULL)->cellHeight * scale;
+    float innerRadius = MAX(LABEL_INNER_RADIUS, labelHeight * numSlots / (2.0f * M_PI));
+    float outerRadius = radius - LABEL_OUTER_PAD;
+    if (innerRadius >= outerRadius) return;
+
+    w->labelScale = scale;
+    for (int i = 0; i < w->numOptions; i++) {
+        layoutWheelLabel(&w->optionsLabel[i], w->options[i], scale, innerRadius, outerRadius);
+    }
+}
+
 static void updateWheelOptions(Wheel *w) {
-    C2D_TextBufClear(dynamicTextBuf);
+    C2D_TextBufClear(w->textBuf);
     for (int i = 0; i < w->numOptions; i++) {
-        C2D_TextParse(&w->optionsText[i], dynamicTextBuf, w->options[i]);
+        C2D_TextParse(&w->optionsText[i], w->textBuf, w->options[i]);
         C2D_TextOptimize(&w->optionsText[i]);
     }
+
+    updateWheelLabels(w);
+}
+
+static void setWheelOptionLine(Wheel *w, int idx, const char *line) {
+    // line may point into w->options
+    char buf[MAX_OPTION_LEN];
+    strncpy(buf, line, MAX_OPTION_LEN - 1);
+    buf[MAX_OPTION_LEN - 1] = '\0';
+
+    w->links[idx][0] = '\0';
+
+    char *sep = strstr(buf, LINK_SEPARATOR);
+    if (sep) {
+        // the name becomes a file name, so anything but [A-Za-z0-9_-] means the
+        // line is kept as plain text rather than linking somewhere unexpected
+        const char *name = sep + strlen(LINK_SEPARATOR);
+        size_t len = strlen(name);
+        bool valid = len > 0 && len < MAX_LINK_LEN;
+        for (const char *c = name; *c && valid; c++) {
+            valid = isalnum((unsigned char) *c) || *c == '_' || *c == '-';
+        }
+
+        if (valid) {
+            strncpy(w->links[idx], name, MAX_LINK_LEN);
+            *sep = '\0';
+        }
+    }
+
+    strncpy(w->options[idx], buf, MAX_OPTION_LEN);
+}
+
+Wheel *newWheel(const char *name) {
+    Wheel *w = malloc(sizeof(Wheel));
+    if (!w) return NULL;
+
+    w->textBuf = C2D_TextBufNew(4096);
+    if (!w->textBuf) {
+        free(w);
+        return NULL;
+    }
+
+    strncpy(w->name, name, MAX_LINK_LEN - 1);
+    w->name[MAX_LINK_LEN - 1] = '\0';
+
+    initWheel(w);
+    fetchWheelOptions(w);
+
+    return w;
 }
 
+void freeWheel(Wheel *w) {
+    C2D_TextBufDelete(w->textBuf);
+    free(w);
+}
 
 void initWheel(Wheel *w) {
     w->centerX = 200.0f;
@@ -30,14 +194,15 @@ void initWheel(Wheel *w) {
     w->spinning = false;
     w->finishedSpin = false;
 
+    w->duplicated = false;
+    w->dirty = false;
 
     w->selectedOption = 0;
     strncpy(w->options[0], "Option 1", MAX_OPTION_LEN);
     strncpy(w->options[1], "Option 2", MAX_OPTION_LEN);
     strncpy(w->options[2], "Option 3", MAX_OPTION_LEN);
+    w->links[0][0] = w->links[1][0] = w->links[2][0] = '\0';
     w->numOptions = 3;
-
-    updateWheelOptions(w);
 }
 
 
@@ -57,16 +222,52 @@ int getColorIndex(int i, int numOptions, int sectorsPerOption, bool duplicated)
     return idx;
 }
 
+static void drawWheelLabels(const Wheel *w, int numOptions, int sectorsPerOption) {
+    if (w->labelScale <= 0.0f) return;
+
+    C2D_ImageTint lightTint, darkTint;
+    C2D_PlainImageTint(&lightTint, white, 1.0f);
+    C2D_PlainImageTint(&darkTint, black, 1.0f);
+
+    int numSlots = w->numOptions * (w->duplicated ? 3 : 1);
+    float anglePerSlot = 360.0f / numSlots;
+
+    for (int i = 0; i < numSlots; i++) {
+        const WheelLabel *label = &w->optionsLabel[i % w->numOptions];
+        int colorIdx = getColorIndex(i * sectorsPerOption, numOptions, sectorsPerOption, w->duplicated);
+
+        // rotate the cached glyph quads into place instead of laying the text out again.
+        // this is done here rather than with C2D_ViewRotate, since changing the view
+        // flushes the batch and would cost a draw call per sector
+        float a = DEG2RAD((i + 0.5f) * anglePerSlot + w->angle);
+        float c = cosf(a), s = sinf(a);
+
+        for (int j = 0; j < label->numGlyphs; j++) {
+            const WheelGlyph *g = &label->glyphs[j];
+            C2D_Image img = { &glyphSheets[g->sheet], &g->subtex };
+
+            float width = g->subtex.width * w->labelScale;
+            float height = g->subtex.height * w->labelScale;
+            float x = g->x + width / 2.0f;
+            float y = g->y + height / 2.0f;
+
+            C2D_DrawParams params = {
+                    { w->centerX + x * c + y * s, w->centerY - x * s + y * c, width, height },
+                    { width / 2.0f, height / 2.0f },
+                    0.0f,
+                    -a
+            };
+            C2D_DrawImage(img, &params, darkText[colorIdx] ? &darkTint : &lightTint);
+        }
+    }
+}
+
 void drawWheel(const Wheel *w) {
     if (w->numOptions == 0) return;
 
     int sectorsPerOption = w->numOptions == 1 ? 4 : w->numOptions > 3 ? 1 : 2;
 
-    float radius = w->radius;
-    if (w->numOptions <= 3) {
-        // looks weird going from 4 to 3 colors without this
-        radius *= 0.9f;
-    }
+    float radius = getWheelRadius(w);
 
     int numOptions = MAX(w->numOptions * sectorsPerOption, 1);
     int numSectors = numOptions * (w->duplicated ? 3 : 1);
@@ -92,6 +293,8 @@ void drawWheel(const Wheel *w) {
         );
     }
 
+    drawWheelLabels(w, numOptions, sectorsPerOption);
+
     C2D_DrawTriangle(w->centerX - 10.5f, w->centerY - 10.5f, black,
                      w->centerX + 10.5f, w->centerY - 10.5f, black,
                      w->centerX, w->centerY - 24.0f, black, 0);
@@ -184,6 +387,18 @@ void drawWheelOptions(const Wheel *w, float scrollOffset) {
                           HEIGHT - 2 * BORDER,
                           white);
 
+        // link marker, for options that open another wheel
+        if (w->links[i][0]) {
+            C2D_DrawRectSolid(BOTTOM_WIDTH - PAD - HEIGHT - BORDER - TEXT_HPAD - LINK_WIDTH,
+                              (HEIGHT + PAD) * i + PAD + BORDER - scrollOffset, 0.0f,
+                              LINK_WIDTH,
+                              HEIGHT - 2 * BORDER,
+                              white);
+            C2D_DrawText(&linkText, C2D_AlignCenter,
+                         BOTTOM_WIDTH - PAD - HEIGHT - BORDER - TEXT_HPAD - LINK_WIDTH / 2.0f,
+                         (HEIGHT + PAD) * i + PAD + BORDER + TEXT_VPAD - scrollOffset, 0.0f, 0.8f, 0.8f);
+        }
+
         // cross border
         C2D_DrawRectSolid(BOTTOM_WIDTH - PAD - BORDER - HEIGHT,
                           (HEIGHT + PAD) * i + PAD - scrollOffset, 0.0f,
@@ -218,15 +433,26 @@ void addWheelOption(Wheel *w) {
     if (w->numOptions >= MAX_OPTIONS) return;
 
     w->numOptions++;
+    setWheelOptionLine(w, w->numOptions - 1, w->options[w->numOptions - 1]);
+    w->dirty = true;
 
     updateWheelOptions(w);
 }
 
 void modifyWheelOption(Wheel *w, int idx, const char *str) {
-    strncpy(w->options[idx], str, MAX_OPTION_LEN);
+    setWheelOptionLine(w, idx, str);
+    w->dirty = true;
     updateWheelOptions(w);
 }
 
+void getWheelOptionLine(const Wheel *w, int idx, char *out, size_t len) {
+    if (w->links[idx][0]) {
+        snprintf(out, len, "%s%s%s", w->options[idx], LINK_SEPARATOR, w->links[idx]);
+    } else {
+        snprintf(out, len, "%s", w->options[idx]);
+    }
+}
+
 void removeWheelOption(Wheel *w, int idx) {
     if (w->numOptions <= 0) return;
 
@@ -234,7 +460,9 @@ void removeWheelOption(Wheel *w, int idx) {
 
     for (int i = idx; i < w->numOptions; i++) {
         strncpy(w->options[i], w->options[i + 1], MAX_OPTION_LEN);
+        strncpy(w->links[i], w->links[i + 1], MAX_LINK_LEN);
     }
+    w->dirty = true;
 
     updateWheelOptions(w);
 }
@@ -243,44 +471,85 @@ void shuffleWheelOptions(Wheel *w) {
     for (int i = 0; i < w->numOptions; i++) {
         int j = rand() % (i + 1);
         char tmp[MAX_OPTION_LEN];
+        char tmpLink[MAX_LINK_LEN];
         C2D_Text tmpText;
+        WheelLabel tmpLabel;
 
         strncpy(tmp, w->options[i], MAX_OPTION_LEN - 1);
+        strncpy(tmpLink, w->links[i], MAX_LINK_LEN);
         tmpText = w->optionsText[i];
+        tmpLabel = w->optionsLabel[i];
 
         strncpy(w->options[i], w->options[j], MAX_OPTION_LEN - 1);
+        strncpy(w->links[i], w->links[j], MAX_LINK_LEN);
         w->optionsText[i] = w->optionsText[j];
+        w->optionsLabel[i] = w->optionsLabel[j];
 
         strncpy(w->options[j], tmp, MAX_OPTION_LEN - 1);
+        strncpy(w->links[j], tmpLink, MAX_LINK_LEN);
         w->optionsText[j] = tmpText;
+        w->optionsLabel[j] = tmpLabel;
     }
+
+    w->dirty = true;
 }
 
-void fetchWheelOptions(Wheel *w) {
-    FILE *f = fopen("sdmc:/3ds/3ds-spinner/options.txt", "r");
-    if (!f) return;
-
-    char line[MAX_OPTION_LEN];
-    int i = 0;
-    while (fgets(line, MAX_OPTION_LEN, f) != NULL) {
-        line[strcspn(line, "\n")] = 0;
-        strncpy(w->options[i], line, MAX_OPTION_LEN);
-        i++;
+void setWheelDuplicated(Wheel *w, bool duplicated) {
+    w->duplicated = duplicated;
+    w->dirty = true;
+
+    // the number of sectors changed, so the labels need to be refitted
+    updateWheelLabels(w);
+}
+
+#define WHEEL_PATH_LEN (MAX_LINK_LEN + 64)
+
+static void getOptionsPath(const Wheel *w, char *out) {
+    if (w->name[0]) {
+        snprintf(out, WHEEL_PATH_LEN, "sdmc:/3ds/3ds-spinner/wheels/%s.txt", w->name);
+    } else {
+        snprintf(out, WHEEL_PATH_LEN, "sdmc:/3ds/3ds-spinner/options.txt");
     }
-    w->numOptions = i;
-    fclose(f);
+}
 
-    if (w->numOptions == 0) {
-        initWheel(w);
+static void getDuplicatedPath(const Wheel *w, char *out) {
+    if (w->name[0]) {
+        snprintf(out, WHEEL_PATH_LEN, "sdmc:/3ds/3ds-spinner/wheels/%s.duplicated", w->name);
     } else {
-        updateWheelOptions(w);
+        snprintf(out, WHEEL_PATH_LEN, "sdmc:/3ds/3ds-spinner/duplicated");
+    }
+}
+
+void fetchWheelOptions(Wheel *w) {
+    char path[WHEEL_PATH_LEN];
+    getOptionsPath(w, path);
+
+    FILE *f = fopen(path, "r");
+    if (f) {
+        char line[MAX_OPTION_LEN];
+        int i = 0;
+        while (i < MAX_OPTIONS && fgets(line, MAX_OPTION_LEN, f) != NULL) {
+            line[strcspn(line, "\n")] = 0;
+            setWheelOptionLine(w, i, line);
+            i++;
+        }
+        w->numOptions = i;
+        fclose(f);
+
+        if (w->numOptions == 0) {
+            initWheel(w);
+        }
     }
 
-    f = fopen("sdmc:/3ds/3ds-spinner/duplicated", "r");
+    getDuplicatedPath(w, path);
+    f = fopen(path, "r");
     if (f) {
         w->duplicated = true;
         fclose(f);
     }
+
+    // text and labels are only prepared once everything has been read
+    updateWheelOptions(w);
 }
 
 void makeMissingDir(const char *path) {
@@ -296,7 +565,14 @@ void makeMissingDir(const char *path) {
 
 void saveWheelOptions(const Wheel *w) {
     makeMissingDir("sdmc:/3ds/3ds-spinner");
-    FILE *f = fopen("sdmc:/3ds/3ds-spinner/options.txt", "w");
+    if (w->name[0]) {
+        makeMissingDir("sdmc:/3ds/3ds-spinner/wheels");
+    }
+
+    char path[WHEEL_PATH_LEN], line[MAX_OPTION_LEN];
+    getOptionsPath(w, path);
+
+    FILE *f = fopen(path, "w");
     if (!f) goto next;
 
     if (w->numOptions == 0) {
@@ -305,17 +581,20 @@ void saveWheelOptions(const Wheel *w) {
     }
 
     for (int i = 0; i < w->numOptions - 1; i++) {
-        fprintf(f, "%s\n", w->options[i]);
+        getWheelOptionLine(w, i, line, MAX_OPTION_LEN);
+        fprintf(f, "%s\n", line);
     }
-    fprintf(f, "%s", w->options[w->numOptions - 1]);
+    getWheelOptionLine(w, w->numOptions - 1, line, MAX_OPTION_LEN);
+    fprintf(f, "%s", line);
     fclose(f);
 
     next:
+    getDuplicatedPath(w, path);
     if (w->duplicated) {
-        f = fopen("sdmc:/3ds/3ds-spinner/duplicated", "w");
+        f = fopen(path, "w");
         if (f) fclose(f);
     } else {
-        remove("sdmc:/3ds/3ds-spinner/duplicated");
+        remove(path);
     }
 }
 
@@ -1,14 +1,26 @@
 #define MAX_OPTIONS 50
 #define MAX_OPTION_LEN 256
+#define MAX_LINK_LEN 64
+
+// an option line "text => name" links to the wheel stored in wheels/name.txt
+#define LINK_SEPARATOR " => "
 
 #define DECELERATION 0.05f
 
+// constants for layout of on-wheel labels:
+#define MAX_LABEL_GLYPHS 24
+#define LABEL_INNER_RADIUS 20.0f // minimum, labels start further out when sectors are narrow
+#define LABEL_OUTER_PAD 6.0f
+#define LABEL_FILL 0.8f
+#define LABEL_MAX_SCALE 0.5f
+#define LABEL_MIN_SCALE 0.25f
 
 // constants for layout of option list:
 #define HEIGHT 35
 #define PAD 1.0f
 #define BORDER 2.0f
 #define CROSS_PAD 4.0f
+#define LINK_WIDTH 20.0f
 #define TEXT_HPAD 4.0f
 #define TEXT_VPAD 2.0f
 
@@ -17,7 +29,24 @@
 #define BTN_HPAD 10.0f
 #define BTN_VPAD 5.0f
 
+// a single glyph of a label, positioned relative to the wheel center with the
+// label pointing along the positive x axis
+typedef struct {
+    Tex3DS_SubTexture subtex;
+    float x;
+    float y;
+    u8 sheet;
+} WheelGlyph;
+
 typedef struct {
+    WheelGlyph glyphs[MAX_LABEL_GLYPHS];
+    int numGlyphs;
+} WheelLabel;
+
+typedef struct {
+    // empty for the root wheel, otherwise the name of its file in wheels/
+    char name[MAX_LINK_LEN];
+
     float centerX;
     float centerY;
     float radius;
@@ -30,13 +59,22 @@ typedef struct {
 
     bool duplicated;
 
+    // changed since it was last loaded or saved
+    bool dirty;
+
     char options[MAX_OPTIONS][MAX_OPTION_LEN];
+    char links[MAX_OPTIONS][MAX_LINK_LEN];
+    C2D_TextBuf textBuf;
     C2D_Text optionsText[MAX_OPTIONS];
+    WheelLabel optionsLabel[MAX_OPTIONS];
+    float labelScale;
 
     int selectedOption;
     int numOptions;
 } Wheel;
 
+Wheel *newWheel(const char *name);
+void freeWheel(Wheel *w);
 void initWheel(Wheel *w);
 void updateWheel(Wheel *w);
 void drawWheel(const Wheel *w);
@@ -45,8 +83,10 @@ void spinWheelTo(Wheel *w, float angle);
 void drawWheelOptions(const Wheel *w, float scrollOffset);
 void addWheelOption(Wheel *w);
 void modifyWheelOption(Wheel *w, int idx, const char *str);
+void getWheelOptionLine(const Wheel *w, int idx, char *out, size_t len);
 void removeWheelOption(Wheel *w, int idx);
 void shuffleWheelOptions(Wheel *w);
+void setWheelDuplicated(Wheel *w, bool duplicated);
 
 int getColorIndex(int i, int numSectors, int sectorsPerOption, bool duplicated);
 